@@ -7,67 +7,122 @@
 #include "error.h"
 #include "openglmanager.h"
 
-// fonts
-#include "roboto.inl"
-#include "gkaiu59.inl"
-#include "martel.inl"
-
 #include <GLFW/glfw3.h>
 
+// set by cmake to the fonts folder of the repository
+#ifndef FONT_DIRECTORY
+#define FONT_DIRECTORY "fonts/"
+#endif
+
+// metadata of the fonts, written in the working directory
+#define FONT_CACHE "fonts.cache"
+
 // ------------------declarations------------------
 FT_Library demo::library		= nullptr;
 FT_Face demo::face				= nullptr;
+font_registry * demo::fonts		= nullptr;
+int demo::font_index			= 0;
 texture * demo::default_tex		= nullptr;
 texture * demo::sdf_tex			= nullptr;
 
 int demo::glyph_index			= 35;
 int demo::pixel_size			= 256;
 int demo::spread				= 8;
+bool demo::propagate			= false;
+bool demo::warm_start			= false;
+bool demo::block_culling		= false;
+
+SDF_Field demo::glyph_field;
+int demo::field_spread			= 32;
+
+SDF_Profile demo::glyph_profile;
+SDF_Profile demo::bench_profile;
+
+SDF_Error demo::glyph_error;
+bool demo::has_error			= false;
+
+sdf_atlas * demo::text_atlas	= nullptr;
+text_batch * demo::batch		= nullptr;
+bool demo::show_text			= false;
+char demo::text[256]			= "The quick brown fox jumps over the lazy dog.";
+float demo::text_size			= 24.0f;
+int demo::text_lines			= 1;
+double demo::layout_time		= 0.0;
 // ------------------------------------------------
 
 static int x[2] = { 0, 0 };
 
 void demo::init() {
+	SDF_Field_Init(&glyph_field);
+
 	FT_CALL(FT_Init_FreeType(&library));
-	//FT_CALL(FT_New_Memory_Face(library, GKAIU59, GKAIU59_SIZE, 0, &face));
-	FT_CALL(FT_New_Memory_Face(library, ROBOTO_REGULAR, ROBOTO_REGULAR_SIZE, 0, &face));
-	//FT_CALL(FT_New_Memory_Face(library, MARTEL, MARTEL_SIZE, 0, &face));
-	FT_CALL(FT_Set_Pixel_Sizes(face, pixel_size, 0));
-	FT_CALL(FT_Load_Glyph(face, glyph_index, FT_LOAD_RENDER));
+
+	// only the fonts that get selected are ever opened
+	fonts = new font_registry(library);
+	fonts->add("Roboto", FONT_DIRECTORY "Roboto-Regular.ttf");
+	fonts->add("AR PL KaitiM GB", FONT_DIRECTORY "gkaiu59.pfb");
+	fonts->add("Martel", FONT_DIRECTORY "Martel-UltraLight.ttf");
+	fonts->load_cache(FONT_CACHE);
+
+	text_atlas = new sdf_atlas();
+	batch = new text_batch(1 << 16);
+	update_font();
+	if (!face) {
+		LOG_ERROR("Cannot open the fonts in %s", FONT_DIRECTORY);
+		return;
+	}
 
 	FT_Bitmap sdf;
 	FT_Bitmap_Init(&sdf);
 
-	Generate_SDF(library, face->glyph, spread, &sdf);
+	SDF_Params params;
+	SDF_Params_Init(&params);
+	params.spread = spread;
+	params.profile = &bench_profile;
 
-	sdf_tex = new texture(sdf.buffer, sdf.width, sdf.rows, GL_R32F, GL_RED, GL_FLOAT, GL_LINEAR);
-	default_tex = new texture(face->glyph->bitmap.buffer, face->glyph->bitmap.width, face->glyph->bitmap.rows, GL_RGBA, GL_RED, GL_UNSIGNED_BYTE, GL_NEAREST);
+	double complete_time = 0.0;
 
-	FT_Bitmap_Done( library, &sdf );
+	SDF_Profile_Reset(&bench_profile);
 
-	double complete_time = 0.0;
+	FT_CALL(FT_Set_Pixel_Sizes(face, pixel_size, 0));
 
 	for ( unsigned int i = 5; i < 106; i++ )
 	{
-		FT_CALL(FT_Load_Glyph(face, i, FT_LOAD_RENDER));
+		FT_CALL(FT_Load_Glyph(face, i, FT_LOAD_NO_BITMAP));
 		
 		auto start = glfwGetTime();
 		
-		Generate_SDF( library, face->glyph, spread, &sdf );
+		Generate_SDF_Ex( library, face->glyph, &params, &sdf );
 		
 		auto end = glfwGetTime();
 		complete_time += ( end - start );
 	}
 
+	FT_Bitmap_Done( library, &sdf );
+
 	LOG_INFO("Total Time: %f", complete_time);
+	LOG_INFO("  decompose: %f ms, distance: %f ms, sign: %f ms, normalize: %f ms",
+		bench_profile.decompose_ns / 1e6, bench_profile.distance_ns / 1e6,
+		bench_profile.sign_ns / 1e6, bench_profile.normalize_ns / 1e6);
+	LOG_INFO("  edges: %llu, pixel-edge evaluations: %llu, newton iterations: %llu",
+		(unsigned long long)bench_profile.num_edges, (unsigned long long)bench_profile.pixel_edge_evals,
+		(unsigned long long)bench_profile.newton_iterations);
  }
 
 void demo::update() {
+	if (!face)
+		return;
+
 	opengl_manager::clear_fbo(opengl_manager::SDF_FBO);
 	opengl_manager::clear_fbo(opengl_manager::DEFAULT_FBO);
 
-	opengl_manager::draw(sdf_tex, glm::vec2(0.0f), glm::vec2(sdf_tex->get_width(), sdf_tex->get_height()),
-		opengl_manager::SDF_SHADER, opengl_manager::SDF_FBO);
+	if (show_text) {
+		layout_text();
+		opengl_manager::draw_text(text_atlas->get_texture(), *batch, glm::vec2(0.0f), opengl_manager::SDF_FBO);
+	} else {
+		opengl_manager::draw(sdf_tex, glm::vec2(0.0f), glm::vec2(sdf_tex->get_width(), sdf_tex->get_height()),
+			opengl_manager::SDF_SHADER, opengl_manager::SDF_FBO);
+	}
 
 	opengl_manager::draw(default_tex, glm::vec2(0.0f), glm::vec2(default_tex->get_width(), default_tex->get_height()),
 		opengl_manager::DEFAULT_SHADER, opengl_manager::DEFAULT_FBO);
@@ -75,6 +130,23 @@ void demo::update() {
 
 void demo::gui() {
 	if (ImGui::Begin("Properties", (bool *)0, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoResize)) {
+		if (ImGui::BeginCombo("Font", fonts->get_name(font_index))) {
+			for (int i = 0; i < fonts->size(); i++) {
+				// with the cache the fonts that are not selected stay closed
+				const font_registry::metadata * meta = nullptr;
+				char label[128];
+				if (fonts->get_metadata(i, &meta) == FT_Err_Ok)
+					snprintf(label, sizeof(label), "%s %s (%ld glyphs)", meta->family.c_str(), meta->style.c_str(), meta->num_glyphs);
+				else
+					snprintf(label, sizeof(label), "%s", fonts->get_name(i));
+
+				if (ImGui::Selectable(label, i == font_index) && i != font_index) {
+					font_index = i;
+					update_font();
+				}
+			}
+			ImGui::EndCombo();
+		}
 		if (ImGui::InputInt("Glyph Index", &glyph_index)) {
 			update_glyph();
 		}
@@ -82,39 +154,224 @@ void demo::gui() {
 			update_glyph();
 		}
 		if (ImGui::SliderInt("Spread", &spread, 1, 100)) {
+			if (spread <= (int)glyph_field.spread)
+				update_spread();
+			else
+				update_glyph();
+		}
+		if (ImGui::Checkbox("Narrow band + propagation", &propagate)) {
+			update_glyph();
+		}
+		if (ImGui::Checkbox("Warm started roots", &warm_start)) {
+			update_glyph();
+		}
+		if (ImGui::Checkbox("Block culling", &block_culling)) {
 			update_glyph();
 		}
+		if (ImGui::Button("Compare with brute force")) {
+			estimate_error();
+		}
+		if (ImGui::Button("Generate whole font")) {
+			generate_font();
+		}
+		ImGui::Separator();
+		ImGui::Checkbox("Show text", &show_text);
+		ImGui::InputTextMultiline("Text", text, sizeof(text));
+		ImGui::SliderFloat("Text size", &text_size, 4.0f, 200.0f);
+		ImGui::SliderInt("Text lines", &text_lines, 1, 5000);
+		ImGui::Text("%d glyphs laid out in %.3f ms", (int)batch->size(), layout_time * 1e3);
+		ImGui::Separator();
 		if (ImGui::DragInt2("Temp", x)) {
 			update_glyph();
 		}
 	}
 	ImGui::End();
+
+	profiler_gui();
+}
+
+void demo::profiler_gui() {
+	if (ImGui::Begin("Profiler", (bool *)0, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoResize)) {
+		const SDF_Profile & p = glyph_profile;
+		const double total = p.total_ns > 0 ? (double)p.total_ns : 1.0;
+
+		struct { const char * name; FT_UInt64 ns; } phases[] = {
+			{ "Decompose", p.decompose_ns },
+			{ "Distance",  p.distance_ns  },
+			{ "Propagate", p.propagate_ns },
+			{ "Sign",      p.sign_ns      },
+			{ "Normalize", p.normalize_ns }
+		};
+
+		ImGui::Text("Last glyph: %.3f ms", p.total_ns / 1e6);
+		ImGui::Separator();
+		for (const auto & phase : phases) {
+			char overlay[32];
+			snprintf(overlay, sizeof(overlay), "%.3f ms", phase.ns / 1e6);
+			ImGui::ProgressBar((float)(phase.ns / total), ImVec2(200.0f, 0.0f), overlay);
+			ImGui::SameLine();
+			ImGui::Text("%s", phase.name);
+		}
+		ImGui::Separator();
+		ImGui::Text("Contours:          %llu", (unsigned long long)p.num_contours);
+		ImGui::Text("Edges:             %llu", (unsigned long long)p.num_edges);
+		ImGui::Text("Pixels:            %llu", (unsigned long long)p.num_pixels);
+		ImGui::Text("Pixel-edge evals:  %llu", (unsigned long long)p.pixel_edge_evals);
+		ImGui::Text("Culled evals:      %llu", (unsigned long long)p.culled_evals);
+		ImGui::Text("Cubic solves:      %llu", (unsigned long long)p.cubic_solves);
+		ImGui::Text("Newton iterations: %llu", (unsigned long long)p.newton_iterations);
+		ImGui::Text("Warm starts:       %llu", (unsigned long long)p.warm_starts);
+		if (has_error) {
+			ImGui::Separator();
+			ImGui::Text("Max error:         %.4f px", glyph_error.max_error);
+			ImGui::Text("Mean error:        %.4f px", glyph_error.mean_error);
+			ImGui::Text("Sign errors:       %u", glyph_error.sign_errors);
+		}
+		ImGui::Separator();
+		ImGui::Text("Startup benchmark (%llu glyphs): %.3f ms",
+			(unsigned long long)bench_profile.num_calls, bench_profile.total_ns / 1e6);
+	}
+	ImGui::End();
 }
 
 void demo::destroy() {
 	if (default_tex) delete default_tex;
 	if (sdf_tex) delete sdf_tex;
+	delete text_atlas;
+	delete batch;
+
+	SDF_Field_Done(&glyph_field);
 
-	FT_CALL(FT_Done_Face(face));
+	// the registry owns the faces
+	fonts->save_cache(FONT_CACHE);
+	delete fonts;
+	face = nullptr;
 	FT_CALL(FT_Done_FreeType(library));
 }
 
+void demo::update_font() {
+	FT_Face font_face = nullptr;
+	FT_CALL(fonts->get_face(font_index, &font_face));
+	if (!font_face)
+		return;
+
+	face = font_face;
+	update_glyph();
+
+	FT_ULong ascii[127 - 32];
+	for (FT_ULong c = 32; c < 127; c++)
+		ascii[c - 32] = c;
+
+	FT_CALL(text_atlas->build(library, face, 64, 8, ascii, 127 - 32, 4));
+}
+
 void demo::update_glyph() {
 	FT_CALL(FT_Set_Pixel_Sizes(face, pixel_size, 0));
-	FT_CALL(FT_Load_Glyph(face, glyph_index, FT_LOAD_RENDER));
+	FT_CALL(FT_Load_Glyph(face, glyph_index, FT_LOAD_NO_BITMAP));
 
 	FT_Bitmap sdf;
 	FT_Bitmap_Init(&sdf);
 
-	Generate_SDF(library, face->glyph, spread, &sdf);
+	SDF_Params params;
+	SDF_Params_Init(&params);
+	params.spread = spread > field_spread ? spread : field_spread;
+	params.flags = (propagate ? SDF_FLAG_PROPAGATE : 0) | (warm_start ? SDF_FLAG_WARM_START : 0) |
+		(block_culling ? SDF_FLAG_BLOCK_CULLING : 0);
+	params.profile = &glyph_profile;
 
-	//((float *)sdf.buffer)[x[1] * sdf.width + x[0]] = 1.0f;
+	SDF_Profile_Reset(&glyph_profile);
+	FT_CALL(Generate_SDF_Incremental(library, face->glyph, &params, &glyph_field, &sdf));
 
-	delete default_tex;
-	delete sdf_tex;
+	FT_Bitmap_Done( library, &sdf );
+
+	// the generator only needs the outline, the glyph is rendered for the preview
+	FT_CALL(FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL));
 
+	delete default_tex;
 	default_tex = new texture(face->glyph->bitmap.buffer, face->glyph->bitmap.width, face->glyph->bitmap.rows, GL_RGBA, GL_RED, GL_UNSIGNED_BYTE, GL_NEAREST);
+
+	update_spread();
+
+	has_error = false;
+}
+
+void demo::update_spread() {
+	FT_Bitmap sdf;
+	FT_Bitmap_Init(&sdf);
+
+	FT_CALL(SDF_Field_Respread(library, &glyph_field, spread, &sdf));
+
+	//((float *)sdf.buffer)[x[1] * sdf.width + x[0]] = 1.0f;
+
+	delete sdf_tex;
 	sdf_tex = new texture(sdf.buffer, sdf.width, sdf.rows, GL_R32F, GL_RED, GL_FLOAT, GL_LINEAR);
 
 	FT_Bitmap_Done( library, &sdf );
 }
+
+void demo::estimate_error() {
+	FT_CALL(FT_Set_Pixel_Sizes(face, pixel_size, 0));
+	FT_CALL(FT_Load_Glyph(face, glyph_index, FT_LOAD_NO_BITMAP));
+
+	SDF_Params params;
+	SDF_Params_Init(&params);
+	params.spread = spread;
+	params.flags = (propagate ? SDF_FLAG_PROPAGATE : 0) | (warm_start ? SDF_FLAG_WARM_START : 0) |
+		(block_culling ? SDF_FLAG_BLOCK_CULLING : 0);
+
+	FT_CALL(SDF_Estimate_Error(library, face->glyph, &params, &glyph_error));
+	has_error = true;
+}
+
+static FT_Error count_glyph(FT_UInt, const FT_Bitmap * bitmap, FT_Int, FT_Int, void * user) {
+	*(FT_UInt64 *)user += (FT_UInt64)bitmap->width * bitmap->rows;
+	return FT_Err_Ok;
+}
+
+void demo::generate_font() {
+	SDF_Worker_Stats stats[64];
+	FT_UInt64 num_pixels = 0;
+
+	SDF_Font_Params params;
+	SDF_Font_Params_Init(&params);
+	params.params.spread = spread;
+	params.params.flags = (propagate ? SDF_FLAG_PROPAGATE : 0) | (warm_start ? SDF_FLAG_WARM_START : 0) |
+		(block_culling ? SDF_FLAG_BLOCK_CULLING : 0);
+	params.pixel_size = pixel_size;
+	params.num_threads = SDF_Num_Processors();
+	if (params.num_threads > 64)
+		params.num_threads = 64;
+	params.func = count_glyph;
+	params.user = &num_pixels;
+	params.stats = stats;
+
+	const FT_Byte * file_base = nullptr;
+	FT_Long file_size = 0;
+	FT_CALL(fonts->get_data(font_index, &file_base, &file_size));
+	if (!file_base)
+		return;
+
+	auto start = glfwGetTime();
+	FT_CALL(Generate_SDF_Font(library, file_base, file_size, 0, &params));
+	auto end = glfwGetTime();
+
+	LOG_INFO("Whole font: %f s, %llu pixels, %u threads", end - start,
+		(unsigned long long)num_pixels, params.num_threads);
+	for (FT_UInt i = 0; i < params.num_threads; i++) {
+		const SDF_Worker_Stats & w = stats[i];
+		LOG_INFO("  worker %u: %u glyphs, %u steals, utilization %.1f%%", i,
+			w.num_glyphs, w.num_steals,
+			w.total_ns ? 100.0 * w.busy_ns / w.total_ns : 0.0);
+	}
+}
+
+void demo::layout_text() {
+	auto start = glfwGetTime();
+
+	// every line is a run of its own, from the top left of the framebuffer
+	batch->clear();
+	for (int i = 0; i < text_lines && batch->size() < batch->capacity(); i++)
+		batch->add_run(text, *text_atlas, text_size, glm::vec2(-440.0f, -440.0f + text_size * (i + 1)));
+
+	layout_time = glfwGetTime() - start;
+}
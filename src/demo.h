@@ -6,7 +6,12 @@
 #include FT_FREETYPE_H
 #include FT_BITMAP_H
 
+#include <sdfgen.h>
+
 #include "texture.h"
+#include "fontregistry.h"
+#include "sdfatlas.h"
+#include "textbatch.h"
 
 class demo {
 public:
@@ -15,16 +20,52 @@ public:
 	static void gui();
 	static void destroy();
 private:
+	static void update_font();
 	static void update_glyph();
+	static void update_spread();
+	static void profiler_gui();
+	static void estimate_error();
+	static void generate_font();
+	static void layout_text();
 private:
 	static FT_Library library;
 	static FT_Face face;
+
+	// the bundled fonts, `face' is the face of the font `font_index'
+	static font_registry * fonts;
+	static int font_index;
 	static texture * default_tex;
 	static texture * sdf_tex;
 
 	static int glyph_index;
 	static int pixel_size;
 	static int spread;
+	static bool propagate;
+	static bool warm_start;
+	static bool block_culling;
+
+	// raw distances of the current glyph, generated with at least
+	// field_spread so that smaller spreads do not need a regeneration
+	static SDF_Field glyph_field;
+	static int field_spread;
+
+	// timings of the last generated glyph and of the startup benchmark
+	static SDF_Profile glyph_profile;
+	static SDF_Profile bench_profile;
+
+	// difference with the brute force generator, see estimate_error()
+	static SDF_Error glyph_error;
+	static bool has_error;
+
+	// text drawn with the printable ascii characters packed in an atlas,
+	// the runs are laid out again every frame
+	static sdf_atlas * text_atlas;
+	static text_batch * batch;
+	static bool show_text;
+	static char text[256];
+	static float text_size;
+	static int text_lines;
+	static double layout_time;
 };
 
 #endif //_DEMO_H_
@@ -0,0 +1,206 @@
+#include "fontregistry.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include FT_TRUETYPE_TABLES_H
+
+font_registry::font_registry(FT_Library library) :
+	m_library(library) {
+}
+
+font_registry::~font_registry() {
+	for (font & f : m_fonts) {
+		if (f.face)
+			FT_Done_Face(f.face);
+	}
+}
+
+int font_registry::add(const char * name, const char * path) {
+	font f;
+	f.name = name;
+	f.path = path;
+	f.face = nullptr;
+	f.has_meta = false;
+	f.file_size = f.file_time = 0;
+	m_fonts.push_back(f);
+
+	return (int)m_fonts.size() - 1;
+}
+
+FT_Error font_registry::get_face(int index, FT_Face * aface) {
+	if (index < 0 || index >= (int)m_fonts.size() || !aface)
+		return FT_Err_Invalid_Argument;
+
+	font & f = m_fonts[index];
+	if (!f.face) {
+		// the unix stream of freetype maps the file instead of reading it
+		FT_Error error = FT_New_Face(m_library, f.path.c_str(), 0, &f.face);
+		if (error != FT_Err_Ok) {
+			f.face = nullptr;
+			return error;
+		}
+	}
+
+	*aface = f.face;
+	return FT_Err_Ok;
+}
+
+FT_Error font_registry::get_data(int index, const FT_Byte ** abase, FT_Long * asize) {
+	if (!abase || !asize)
+		return FT_Err_Invalid_Argument;
+
+	FT_Face face;
+	FT_Error error = get_face(index, &face);
+	if (error != FT_Err_Ok)
+		return error;
+
+	if (face->stream->base) {
+		*abase = face->stream->base;
+		*asize = (FT_Long)face->stream->size;
+		return FT_Err_Ok;
+	}
+
+	// streams that read on demand, the file is read only once
+	font & f = m_fonts[index];
+	if (f.data.empty()) {
+		FILE * file = fopen(f.path.c_str(), "rb");
+		if (!file)
+			return FT_Err_Cannot_Open_Resource;
+
+		f.data.resize(face->stream->size);
+		const size_t read = fread(f.data.data(), 1, f.data.size(), file);
+		fclose(file);
+
+		if (read != f.data.size()) {
+			f.data.clear();
+			return FT_Err_Cannot_Open_Stream;
+		}
+	}
+
+	*abase = f.data.data();
+	*asize = (FT_Long)f.data.size();
+	return FT_Err_Ok;
+}
+
+FT_Error font_registry::get_metadata(int index, const metadata ** ameta) {
+	if (index < 0 || index >= (int)m_fonts.size() || !ameta)
+		return FT_Err_Invalid_Argument;
+
+	font & f = m_fonts[index];
+
+	long long file_size, file_time;
+	if (!get_file_stamp(f.path, &file_size, &file_time))
+		return FT_Err_Cannot_Open_Resource;
+
+	if (!f.has_meta || f.file_size != file_size || f.file_time != file_time) {
+		FT_Face face;
+		FT_Error error = get_face(index, &face);
+		if (error != FT_Err_Ok)
+			return error;
+
+		metadata & m = f.meta;
+		m.family = face->family_name ? face->family_name : "";
+		m.style = face->style_name ? face->style_name : "";
+		m.num_glyphs = face->num_glyphs;
+		m.units_per_em = face->units_per_EM;
+		m.ascender = face->ascender;
+		m.descender = face->descender;
+		m.height = face->height;
+
+		const TT_OS2 * os2 = (const TT_OS2 *)FT_Get_Sfnt_Table(face, FT_SFNT_OS2);
+		m.unicode_ranges[0] = os2 ? os2->ulUnicodeRange1 : 0;
+		m.unicode_ranges[1] = os2 ? os2->ulUnicodeRange2 : 0;
+		m.unicode_ranges[2] = os2 ? os2->ulUnicodeRange3 : 0;
+		m.unicode_ranges[3] = os2 ? os2->ulUnicodeRange4 : 0;
+
+		// the names end the lines of the cache
+		for (std::string * name : { &m.family, &m.style }) {
+			for (char & c : *name) {
+				if (c == '\t' || c == '\n' || c == '\r')
+					c = ' ';
+			}
+		}
+
+		f.has_meta = true;
+		f.file_size = file_size;
+		f.file_time = file_time;
+	}
+
+	*ameta = &f.meta;
+	return FT_Err_Ok;
+}
+
+bool font_registry::load_cache(const char * path) {
+	FILE * file = fopen(path, "r");
+	if (!file)
+		return false;
+
+	// one line per font, the fields are separated by tabs
+	char line[4096];
+	while (fgets(line, sizeof(line), file)) {
+		std::vector<std::string> fields(1);
+		for (const char * c = line; *c && *c != '\n' && *c != '\r'; c++) {
+			if (*c == '\t')
+				fields.emplace_back();
+			else
+				fields.back() += *c;
+		}
+		if (fields.size() != 14)
+			continue;
+
+		for (font & f : m_fonts) {
+			if (f.path != fields[0])
+				continue;
+
+			metadata & m = f.meta;
+			f.file_size = strtoll(fields[1].c_str(), nullptr, 10);
+			f.file_time = strtoll(fields[2].c_str(), nullptr, 10);
+			m.num_glyphs = strtol(fields[3].c_str(), nullptr, 10);
+			m.units_per_em = (int)strtol(fields[4].c_str(), nullptr, 10);
+			m.ascender = (int)strtol(fields[5].c_str(), nullptr, 10);
+			m.descender = (int)strtol(fields[6].c_str(), nullptr, 10);
+			m.height = (int)strtol(fields[7].c_str(), nullptr, 10);
+			for (int i = 0; i < 4; i++)
+				m.unicode_ranges[i] = strtoul(fields[8 + i].c_str(), nullptr, 10);
+			m.family = fields[12];
+			m.style = fields[13];
+			f.has_meta = true;
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+bool font_registry::save_cache(const char * path) const {
+	FILE * file = fopen(path, "w");
+	if (!file)
+		return false;
+
+	for (const font & f : m_fonts) {
+		if (!f.has_meta)
+			continue;
+
+		const metadata & m = f.meta;
+		fprintf(file, "%s\t%lld\t%lld\t%ld\t%d\t%d\t%d\t%d\t%lu\t%lu\t%lu\t%lu\t%s\t%s\n",
+			f.path.c_str(), f.file_size, f.file_time, m.num_glyphs,
+			m.units_per_em, m.ascender, m.descender, m.height,
+			m.unicode_ranges[0], m.unicode_ranges[1], m.unicode_ranges[2], m.unicode_ranges[3],
+			m.family.c_str(), m.style.c_str());
+	}
+
+	return fclose(file) == 0;
+}
+
+bool font_registry::get_file_stamp(const std::string & path, long long * size, long long * time) {
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+		return false;
+
+	*size = (long long)info.st_size;
+	*time = (long long)info.st_mtime;
+	return true;
+}
@@ -0,0 +1,75 @@
+/*
+ * font files opened by path, the face of a font is only created the first
+ * time the font is used. freetype maps the files read only where it can,
+ * so their pages are shared with the other processes using them. the
+ * metadata of the fonts can be kept in a cache file so that listing them
+ * does not open any face
+ */
+
+#ifndef _FONTREGISTRY_H_
+#define _FONTREGISTRY_H_
+
+#include <string>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+class font_registry {
+public:
+	struct metadata {
+		std::string family;
+		std::string style;
+		long num_glyphs;
+		int units_per_em;
+		int ascender, descender, height;	// in font units
+		unsigned long unicode_ranges[4];	// coverage bits of the os/2 table, 0 without one
+	};
+public:
+	font_registry(FT_Library library);
+	~font_registry();
+
+	// register the font file at `path' under `name', nothing is read
+	// yet. returns the index of the font
+	int add(const char * name, const char * path);
+
+	// face of the font `index', created on first use and owned by the
+	// registry, so it must not be done by the caller
+	FT_Error get_face(int index, FT_Face * aface);
+
+	// whole file of the font `index', for the functions that open
+	// faces of their own from memory. it is the mapping of the face
+	// stream when there is one and is read once otherwise
+	FT_Error get_data(int index, const FT_Byte ** abase, FT_Long * asize);
+
+	// metadata of the font `index', from the cache while the size and
+	// modification time of the file are the cached ones, from its face
+	// otherwise
+	FT_Error get_metadata(int index, const metadata ** ameta);
+
+	// the cache only holds the registered fonts, entries of other files
+	// are ignored. both return false if the file cannot be used
+	bool load_cache(const char * path);
+	bool save_cache(const char * path) const;
+
+	inline int size() const { return (int)m_fonts.size(); }
+	inline const char * get_name(int index) const { return m_fonts[index].name.c_str(); }
+private:
+	struct font {
+		std::string name;
+		std::string path;
+		FT_Face face;
+		std::vector<FT_Byte> data;	// empty while the stream is in memory
+
+		metadata meta;
+		bool has_meta;
+		long long file_size, file_time;	// of the file `meta' comes from
+	};
+
+	static bool get_file_stamp(const std::string & path, long long * size, long long * time);
+
+	FT_Library m_library;
+	std::vector<font> m_fonts;
+};
+
+#endif //_FONTREGISTRY_H_
@@ -1,5 +1,7 @@
 #include "openglmanager.h"
 
+#include <cstddef>
+
 #include <imgui.h>
 
 #include "error.h"
@@ -7,6 +9,9 @@
 // ------------------declarations------------------
 GLuint opengl_manager::vertex_buffer;
 GLuint opengl_manager::vertex_array;
+GLuint opengl_manager::instance_buffer;
+GLuint opengl_manager::text_vertex_array;
+size_t opengl_manager::instance_capacity	= 0;
 std::unordered_map<opengl_manager::shaders, GLuint> opengl_manager::shader_programs;
 std::unordered_map<opengl_manager::framebuffers, std::pair<GLuint, texture *>> opengl_manager::fbos;
 
@@ -126,6 +131,29 @@ bool opengl_manager::init(int width, int height) {
 		}
 	)";
 
+	// the unit quad is stretched over the glyph rect of every instance,
+	// the pixel positions have y pointing down like the shown framebuffers
+	const GLchar * text_vertex_shader_code = R"(
+		#version 330 core
+		layout (location = 0) in vec2 in_pos;
+		layout (location = 2) in vec2 in_offset;
+		layout (location = 3) in vec4 in_uv_rect;
+		layout (location = 4) in vec2 in_scale;
+
+		uniform mat4 projection;
+		uniform mat4 model;
+
+		out vec2 pass_tex_coords;
+
+		void main() {
+			vec2 corner = in_pos + 0.5f;
+			vec2 pixel = in_offset + corner * in_scale;
+
+			pass_tex_coords = mix(in_uv_rect.xy, in_uv_rect.zw, corner);
+			gl_Position = projection * model * vec4(pixel.x, pixel.y, 0.0f, 1.0f);
+		}
+	)";
+
 	// create the actual opengl shader object
 	GLuint default_shader_program = create_shader_program(default_vertex_shader_code, default_fragment_shader_code);
 	if (!default_shader_program) return false;
@@ -133,8 +161,12 @@ bool opengl_manager::init(int width, int height) {
 	GLuint sdf_shader_program = create_shader_program(default_vertex_shader_code, sdf_fragment_shader_code);
 	if (!sdf_shader_program) return false;
 
+	GLuint text_shader_program = create_shader_program(text_vertex_shader_code, sdf_fragment_shader_code);
+	if (!text_shader_program) return false;
+
 	shader_programs.insert(std::make_pair(shaders::DEFAULT_SHADER, default_shader_program));
 	shader_programs.insert(std::make_pair(shaders::SDF_SHADER, sdf_shader_program));
+	shader_programs.insert(std::make_pair(shaders::TEXT_SHADER, text_shader_program));
 
 	// ----------------- create vertex arrays -----------------
 	GLuint vao;
@@ -155,6 +187,33 @@ bool opengl_manager::init(int width, int height) {
 	GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0u));
 	GL_CALL(glBindVertexArray(0u));
 
+	// ----------------- create text vertex array -----------------
+	// the quad vertices are shared, the glyph instances advance once per quad
+	GLuint ibo;
+	GL_CALL(glGenBuffers(1, &ibo));
+	instance_buffer = ibo;
+
+	GLuint text_vao;
+	GL_CALL(glGenVertexArrays(1, &text_vao));
+	text_vertex_array = text_vao;
+	GL_CALL(glBindVertexArray(text_vao));
+
+	GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, vbo));
+	GL_CALL(glVertexAttribPointer(0u, 2u, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (const void *)0));
+	GL_CALL(glEnableVertexAttribArray(0u));
+
+	GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, ibo));
+	GL_CALL(glVertexAttribPointer(2u, 2u, GL_FLOAT, GL_FALSE, sizeof(glyph_instance), (const void *)offsetof(glyph_instance, x)));
+	GL_CALL(glVertexAttribPointer(3u, 4u, GL_FLOAT, GL_FALSE, sizeof(glyph_instance), (const void *)offsetof(glyph_instance, u0)));
+	GL_CALL(glVertexAttribPointer(4u, 2u, GL_FLOAT, GL_FALSE, sizeof(glyph_instance), (const void *)offsetof(glyph_instance, scale_x)));
+	for (GLuint attribute = 2u; attribute <= 4u; attribute++) {
+		GL_CALL(glVertexAttribDivisor(attribute, 1u));
+		GL_CALL(glEnableVertexAttribArray(attribute));
+	}
+
+	GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0u));
+	GL_CALL(glBindVertexArray(0u));
+
 	// ----------------- create framebuffers -----------------
 
 	// DEFAULT FRAMEBFUFER
@@ -208,6 +267,9 @@ bool opengl_manager::init(int width, int height) {
 void opengl_manager::destroy() {
 	GL_CALL(glDeleteBuffers(1, &vertex_buffer));
 	GL_CALL(glDeleteVertexArrays(1, &vertex_array));
+	GL_CALL(glDeleteBuffers(1, &instance_buffer));
+	GL_CALL(glDeleteVertexArrays(1, &text_vertex_array));
+	instance_capacity = 0;
 
 	for (auto & shader : shader_programs) {
 		GL_CALL(glDeleteProgram(shader.second));
@@ -259,6 +321,52 @@ void opengl_manager::draw(texture * tex, glm::vec2 position, glm::vec2 dimen, sh
 	GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0u));
 }
 
+void opengl_manager::draw_text(texture * atlas, const text_batch & batch, glm::vec2 position, framebuffers fbo) {
+	if (batch.size() == 0)
+		return;
+
+	glm::mat4 model = glm::mat4(1.0f);
+	model = glm::translate(model, glm::vec3(position + offset, 0.0f));
+	model = glm::scale(model, glm::vec3(zoom, zoom, 1.0f));
+
+	// upload the instances, the buffer only grows with the batch capacity
+	GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, instance_buffer));
+	if (batch.capacity() > instance_capacity) {
+		instance_capacity = batch.capacity();
+		GL_CALL(glBufferData(GL_ARRAY_BUFFER, instance_capacity * sizeof(glyph_instance), NULL, GL_STREAM_DRAW));
+	}
+	GL_CALL(glBufferSubData(GL_ARRAY_BUFFER, 0, batch.size() * sizeof(glyph_instance), (const void *)batch.data()));
+	GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0u));
+
+	GL_CALL(glUseProgram(shader_programs[TEXT_SHADER]));
+	GLuint model_uniform_location = GL_CALL(glGetUniformLocation(shader_programs[TEXT_SHADER], "model"));
+	GLuint projection_uniform_location = GL_CALL(glGetUniformLocation(shader_programs[TEXT_SHADER], "projection"));
+
+	GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, fbos[fbo].first));
+	GL_CALL(glViewport(0, 0, fbos[fbo].second->get_width(), fbos[fbo].second->get_height()));
+
+	GL_CALL(glUniformMatrix4fv(model_uniform_location, 1u, GL_FALSE, glm::value_ptr(model)));
+	GL_CALL(glUniformMatrix4fv(projection_uniform_location, 1u, GL_FALSE, glm::value_ptr(projection)));
+
+	GL_CALL(glBindTexture(GL_TEXTURE_2D, atlas->get_id()));
+	GL_CALL(glBindVertexArray(text_vertex_array));
+
+	// the quads of neighbour glyphs overlap because of the spread,
+	// keep the brightest value so that they do not hide each other
+	GL_CALL(glEnable(GL_BLEND));
+	GL_CALL(glBlendEquation(GL_MAX));
+
+	GL_CALL(glDrawArraysInstanced(GL_TRIANGLES, 0u, 6u, (GLsizei)batch.size()));
+
+	GL_CALL(glBlendEquation(GL_FUNC_ADD));
+	GL_CALL(glDisable(GL_BLEND));
+
+	GL_CALL(glBindTexture(GL_TEXTURE_2D, 0u));
+	GL_CALL(glUseProgram(0u));
+	GL_CALL(glBindVertexArray(0u));
+	GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0u));
+}
+
 void opengl_manager::gui() {
 	ImGuiIO & io = ImGui::GetIO();
 
@@ -286,13 +394,14 @@ void opengl_manager::gui() {
 	ImGui::End();
 
 	if (ImGui::Begin("SDF Framebuffer", (bool *)0, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoResize)) {
+		// the single glyph and the text share the sdf fragment shader
+		const shaders sdf_shaders[] = { SDF_SHADER, TEXT_SHADER };
+
 		if (ImGui::Checkbox("Show Rendererd", &show_rendered)) {
-			GL_CALL(glUseProgram(shader_programs[SDF_SHADER]));
-			GLuint location = GL_CALL(glGetUniformLocation(shader_programs[SDF_SHADER], "show_rendered"));
+			for (shaders shader : sdf_shaders) {
+				GL_CALL(glUseProgram(shader_programs[shader]));
+				GLuint location = GL_CALL(glGetUniformLocation(shader_programs[shader], "show_rendered"));
 
-			if (show_rendered) {
-				GL_CALL(glUniform1i(location, show_rendered));
-			} else {
 				GL_CALL(glUniform1i(location, show_rendered));
 			}
 
@@ -300,18 +409,24 @@ void opengl_manager::gui() {
 		}
 
 		if (ImGui::DragFloat("Width", &swidth, 0.01f, 0.0f)) {
-			GL_CALL(glUseProgram(shader_programs[SDF_SHADER]));
-			GLuint location = GL_CALL(glGetUniformLocation(shader_programs[SDF_SHADER], "width"));
+			for (shaders shader : sdf_shaders) {
+				GL_CALL(glUseProgram(shader_programs[shader]));
+				GLuint location = GL_CALL(glGetUniformLocation(shader_programs[shader], "width"));
+
+				GL_CALL(glUniform1f(location, swidth));
+			}
 
-			GL_CALL(glUniform1f(location, swidth));
 			GL_CALL(glUseProgram(0));
 		}
 
 		if (ImGui::DragFloat("Edge", &sedge, 0.01f, 0.0f)) {
-			GL_CALL(glUseProgram(shader_programs[SDF_SHADER]));
-			GLuint location = GL_CALL(glGetUniformLocation(shader_programs[SDF_SHADER], "edge"));
+			for (shaders shader : sdf_shaders) {
+				GL_CALL(glUseProgram(shader_programs[shader]));
+				GLuint location = GL_CALL(glGetUniformLocation(shader_programs[shader], "edge"));
+
+				GL_CALL(glUniform1f(location, sedge));
+			}
 
-			GL_CALL(glUniform1f(location, sedge));
 			GL_CALL(glUseProgram(0));
 		}
 
@@ -16,12 +16,14 @@
 #include <glad/glad.h>
 
 #include "texture.h"
+#include "textbatch.h"
 
 class opengl_manager {
 public:
     enum shaders {
         DEFAULT_SHADER,
-        SDF_SHADER
+        SDF_SHADER,
+        TEXT_SHADER
     };
 
     enum framebuffers {
@@ -37,6 +39,9 @@ public:
 
     // dimen and pos in pixels
     static void draw(texture * tex, glm::vec2 position, glm::vec2 dimen, shaders shader, framebuffers fbo);
+    // draw all the glyphs of the batch with a single draw call, the
+    // instance positions are in pixels relative to `position'
+    static void draw_text(texture * atlas, const text_batch & batch, glm::vec2 position, framebuffers fbo);
 
     // show the different framebuffers
     static void gui();
@@ -50,6 +55,10 @@ private:
     // opengl specific objects
     static GLuint vertex_buffer;
     static GLuint vertex_array;
+    // per glyph data of the text batches, grown when needed
+    static GLuint instance_buffer;
+    static GLuint text_vertex_array;
+    static size_t instance_capacity;
     static std::unordered_map<shaders, GLuint> shader_programs;
     // pair of fbo objects and it's texture
     static std::unordered_map<framebuffers, std::pair<GLuint, texture *>> fbos;
@@ -0,0 +1,227 @@
+#include "sdfatlas.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include FT_SIZES_H
+
+#include <sdfgen.h>
+
+sdf_atlas::sdf_atlas() :
+	m_width(0), m_height(0), m_texture(nullptr),
+	m_pixel_size(0), m_spread(0), m_num_levels(0), m_line_height(0.0f) {
+	clear();
+}
+
+sdf_atlas::~sdf_atlas() {
+	clear();
+}
+
+void sdf_atlas::clear() {
+	delete m_texture;
+	m_texture = nullptr;
+
+	m_glyphs.clear();
+	m_pixels.clear();
+	m_width = m_height = 0;
+
+	for (int & index : m_ascii)
+		index = -1;
+}
+
+FT_Error sdf_atlas::build(FT_Library library, FT_Face face, int pixel_size, int spread,
+						  const FT_ULong * codepoints, size_t num_codepoints, int num_levels) {
+	clear();
+
+	if (num_levels < 1 || num_levels > max_levels)
+		return FT_Err_Invalid_Argument;
+
+	// the fields are generated with a size of their own, the face can be
+	// shared with code which set its own size
+	FT_Size size;
+	FT_Error error = FT_New_Size(face, &size);
+	if (error != FT_Err_Ok)
+		return error;
+
+	struct size_scope {
+		FT_Size previous, size;
+		~size_scope() {
+			FT_Activate_Size(previous);
+			FT_Done_Size(size);
+		}
+	} scope = { face->size, size };
+
+	error = FT_Activate_Size(size);
+	if (error == FT_Err_Ok)
+		error = FT_Set_Pixel_Sizes(face, 0, pixel_size);
+	if (error != FT_Err_Ok)
+		return error;
+
+	m_pixel_size = pixel_size;
+	m_spread = spread;
+	m_num_levels = num_levels;
+	m_line_height = face->size->metrics.height / 64.0f;
+
+	std::vector<FT_ULong> sorted(codepoints, codepoints + num_codepoints);
+	std::sort(sorted.begin(), sorted.end());
+	sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+	std::vector<FT_UInt> indices(sorted.size());
+	error = FT_Get_Char_Indices(face, sorted.data(), (FT_UInt)sorted.size(), indices.data());
+	if (error != FT_Err_Ok)
+		return error;
+
+	SDF_Params params;
+	SDF_Params_Init(&params);
+	params.spread = spread;
+
+	SDF_Level levels[max_levels];
+	for (SDF_Level & level : levels)
+		FT_Bitmap_Init(&level.bitmap);
+
+	// generate all the fields first, they are packed by height
+	struct field {
+		size_t glyph;
+		int level;
+		int width, height;
+		std::vector<float> pixels;
+	};
+	std::vector<field> fields;
+	std::vector<int> generated(sorted.size(), 0);
+	m_glyphs.reserve(sorted.size());
+
+	for (size_t i = 0; i < sorted.size(); i++) {
+		glyph g = {};
+		g.codepoint = sorted[i];
+
+		error = FT_Load_Glyph(face, indices[i], FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP);
+		if (error != FT_Err_Ok)
+			break;
+
+		g.advance = face->glyph->advance.x / 64.0f;
+
+		// spaces have an advance but no field
+		if (face->glyph->format == FT_GLYPH_FORMAT_OUTLINE && face->glyph->outline.n_points > 0) {
+			error = Generate_SDF_Levels(library, &face->glyph->outline, 0, 0, &params, num_levels, levels);
+
+			// degenerate outlines have nothing to draw
+			const int num_generated = error == FT_Err_Ok ? num_levels : 0;
+			if (error == FT_Err_Invalid_Argument)
+				error = FT_Err_Ok;
+			else if (error != FT_Err_Ok)
+				break;
+
+			// the glyphs vanish in the smallest levels of very small glyphs
+			for (int n = 0; n < num_generated; n++) {
+				const FT_Bitmap & bitmap = levels[n].bitmap;
+				if (bitmap.width == 0 || bitmap.rows == 0)
+					break;
+
+				generated[i] = n + 1;
+
+				// the pixels of the fields hold the distance at their bottom
+				// left corner, which must be the center of the texel
+				const float unit = (float)(1 << n);
+				g.levels[n].left = (levels[n].bitmap_left - 0.5f) * unit;
+				g.levels[n].top = (levels[n].bitmap_top - 0.5f) * unit;
+				g.levels[n].width = bitmap.width * unit;
+				g.levels[n].height = bitmap.rows * unit;
+
+				field f;
+				f.glyph = i;
+				f.level = n;
+				f.width = (int)bitmap.width;
+				f.height = (int)bitmap.rows;
+				f.pixels.resize(bitmap.width * bitmap.rows);
+				for (unsigned int row = 0; row < bitmap.rows; row++)
+					memcpy(&f.pixels[row * bitmap.width], bitmap.buffer + row * bitmap.pitch, bitmap.width * sizeof(float));
+				fields.push_back(std::move(f));
+			}
+		}
+
+		m_glyphs.push_back(g);
+	}
+
+	for (SDF_Level & level : levels)
+		FT_Bitmap_Done(library, &level.bitmap);
+
+	if (error != FT_Err_Ok) {
+		clear();
+		return error;
+	}
+
+	// shelf packing of the fields of every level sorted by decreasing height,
+	// with a pixel of gap between them so that bilinear filtering does not bleed
+	size_t area = 0;
+	int max_width = 1;
+	for (const field & f : fields) {
+		area += (size_t)(f.width + 1) * (size_t)(f.height + 1);
+		max_width = std::max(max_width, f.width + 1);
+	}
+	std::sort(fields.begin(), fields.end(), [](const field & a, const field & b) {
+		return a.height > b.height;
+	});
+
+	m_width = 1;
+	while (m_width < max_width || (size_t)m_width * m_width < area)
+		m_width *= 2;
+
+	std::vector<int> xs(fields.size()), ys(fields.size());
+	int x = 0, y = 0, shelf_height = 0;
+	for (size_t i = 0; i < fields.size(); i++) {
+		if (x + fields[i].width + 1 > m_width) {
+			x = 0;
+			y += shelf_height;
+			shelf_height = 0;
+		}
+		xs[i] = x;
+		ys[i] = y;
+		x += fields[i].width + 1;
+		shelf_height = std::max(shelf_height, fields[i].height + 1);
+	}
+	m_height = std::max(y + shelf_height, 1);
+
+	// the gaps are far outside of every glyph
+	m_pixels.assign((size_t)m_width * m_height, -1.0f);
+
+	for (size_t i = 0; i < fields.size(); i++) {
+		const field & f = fields[i];
+		level & l = m_glyphs[f.glyph].levels[f.level];
+
+		for (int row = 0; row < f.height; row++)
+			memcpy(&m_pixels[(size_t)(ys[i] + row) * m_width + xs[i]], &f.pixels[(size_t)row * f.width], f.width * sizeof(float));
+
+		l.u0 = (float)xs[i] / m_width;
+		l.v0 = (float)ys[i] / m_height;
+		l.u1 = (float)(xs[i] + f.width) / m_width;
+		l.v1 = (float)(ys[i] + f.height) / m_height;
+	}
+
+	for (size_t i = 0; i < m_glyphs.size(); i++) {
+		// the vanished levels use the smallest one left
+		for (int n = std::max(generated[i], 1); n < num_levels; n++)
+			m_glyphs[i].levels[n] = m_glyphs[i].levels[n - 1];
+
+		if (m_glyphs[i].codepoint < 128)
+			m_ascii[m_glyphs[i].codepoint] = (int)i;
+	}
+
+	return FT_Err_Ok;
+}
+
+const sdf_atlas::glyph * sdf_atlas::find(FT_ULong codepoint) const {
+	if (codepoint < 128)
+		return m_ascii[codepoint] < 0 ? nullptr : &m_glyphs[m_ascii[codepoint]];
+
+	auto it = std::lower_bound(m_glyphs.begin(), m_glyphs.end(), codepoint,
+		[](const glyph & g, FT_ULong c) { return g.codepoint < c; });
+
+	return it != m_glyphs.end() && it->codepoint == codepoint ? &*it : nullptr;
+}
+
+texture * sdf_atlas::get_texture() {
+	if (!m_texture && m_width > 0)
+		m_texture = new texture(m_pixels.data(), m_width, m_height, GL_R32F, GL_RED, GL_FLOAT, GL_LINEAR);
+
+	return m_texture;
+}
@@ -0,0 +1,75 @@
+/*
+ * signed distance fields of a set of glyphs packed in a single texture
+ * along with the metrics needed to lay out text with them
+ */
+
+#ifndef _SDFATLAS_H_
+#define _SDFATLAS_H_
+
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "texture.h"
+
+class sdf_atlas {
+public:
+	static const int max_levels = 6;
+
+	// all the sizes are in pixels at the pixel size of the atlas, whatever
+	// the level. the level n has 1/2^n of the resolution of the level 0
+	struct level {
+		float u0, v0, u1, v1;	// rect of the field in the atlas, v0 is the top row
+		float left, top;		// top left corner of the field from the pen position (y up)
+		float width, height;	// size of the field, zero if the glyph has no field
+	};
+
+	struct glyph {
+		FT_ULong codepoint;
+		float advance;
+		level levels[max_levels];
+	};
+public:
+	sdf_atlas();
+	~sdf_atlas();
+
+	// generate and pack the fields of `codepoints' ( sorted or not ) of `face',
+	// with `num_levels' levels of detail computed from the outlines. the
+	// size of `face' is left as it was, the fields use a size of their own.
+	// characters without glyph use the glyph 0.
+	FT_Error build(FT_Library library, FT_Face face, int pixel_size, int spread,
+				   const FT_ULong * codepoints, size_t num_codepoints, int num_levels = 1);
+
+	// nullptr if `codepoint' is not in the atlas, never allocates
+	const glyph * find(FT_ULong codepoint) const;
+
+	// the texture is only created when first needed so that the
+	// atlas can be built without an opengl context
+	texture * get_texture();
+
+	inline int get_pixel_size() const { return m_pixel_size; }
+	inline int get_spread() const { return m_spread; }
+	inline int get_num_levels() const { return m_num_levels; }
+	inline int get_width() const { return m_width; }
+	inline int get_height() const { return m_height; }
+	inline const std::vector<float> & get_pixels() const { return m_pixels; }
+	inline float get_line_height() const { return m_line_height; }
+private:
+	void clear();
+private:
+	// sorted by codepoint, ascii characters are also indexed by m_ascii
+	std::vector<glyph> m_glyphs;
+	int m_ascii[128];
+
+	std::vector<float> m_pixels;
+	int m_width, m_height;
+	texture * m_texture;
+
+	int m_pixel_size;
+	int m_spread;
+	int m_num_levels;
+	float m_line_height;
+};
+
+#endif //_SDFATLAS_H_
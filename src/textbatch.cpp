@@ -0,0 +1,71 @@
+#include "textbatch.h"
+
+// decode the utf-8 character at `*text' and move past it. invalid
+// sequences decode to U+FFFD and only skip their first byte
+static FT_ULong decode_utf8(const unsigned char *& text) {
+	const unsigned char c = *text++;
+
+	int length;
+	FT_ULong codepoint;
+	if (c < 0x80) return c;
+	else if ((c & 0xE0) == 0xC0) { length = 1; codepoint = c & 0x1F; }
+	else if ((c & 0xF0) == 0xE0) { length = 2; codepoint = c & 0x0F; }
+	else if ((c & 0xF8) == 0xF0) { length = 3; codepoint = c & 0x07; }
+	else return 0xFFFD;
+
+	for (int i = 0; i < length; i++) {
+		if ((text[i] & 0xC0) != 0x80)
+			return 0xFFFD;
+		codepoint = (codepoint << 6) | (text[i] & 0x3F);
+	}
+
+	text += length;
+	return codepoint;
+}
+
+text_batch::text_batch(size_t capacity) :
+	m_instances(capacity), m_count(0) {
+}
+
+size_t text_batch::add_run(const char * text, const sdf_atlas & font, float size, glm::vec2 pen) {
+	const float scale = size / font.get_pixel_size();
+	const float start_x = pen.x;
+	const size_t first = m_count;
+
+	// the smallest level whose texels are still no larger than a pixel
+	int lod = 0;
+	while (lod + 1 < font.get_num_levels() && (float)(2 << lod) * scale <= 1.0f)
+		lod++;
+
+	const unsigned char * c = (const unsigned char *)text;
+	while (*c && m_count < m_instances.size()) {
+		const FT_ULong codepoint = decode_utf8(c);
+
+		if (codepoint == '\n') {
+			pen.x = start_x;
+			pen.y += font.get_line_height() * scale;
+			continue;
+		}
+
+		const sdf_atlas::glyph * g = font.find(codepoint);
+		if (!g)
+			continue;
+
+		const sdf_atlas::level & l = g->levels[lod];
+		if (l.width > 0.0f) {
+			glyph_instance & instance = m_instances[m_count++];
+			instance.x = pen.x + l.left * scale;
+			instance.y = pen.y - l.top * scale;
+			instance.u0 = l.u0;
+			instance.v0 = l.v0;
+			instance.u1 = l.u1;
+			instance.v1 = l.v1;
+			instance.scale_x = l.width * scale;
+			instance.scale_y = l.height * scale;
+		}
+
+		pen.x += g->advance * scale;
+	}
+
+	return m_count - first;
+}
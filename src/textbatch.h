@@ -0,0 +1,47 @@
+/*
+ * lay out runs of text with a sdf atlas into a buffer of glyph instances
+ * which are drawn in a single instanced draw call
+ */
+
+#ifndef _TEXTBATCH_H_
+#define _TEXTBATCH_H_
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "sdfatlas.h"
+
+// one glyph of a run, an instance of the unit quad. the positions are
+// in pixels with y pointing down, like the framebuffers are shown
+struct glyph_instance {
+	float x, y;				// top left corner
+	float u0, v0, u1, v1;	// rect in the atlas
+	float scale_x, scale_y;	// size of the quad
+};
+
+class text_batch {
+public:
+	// all the memory is allocated here, adding runs never allocates
+	explicit text_batch(size_t capacity);
+
+	// remove all the glyphs, the memory is kept
+	inline void clear() { m_count = 0; }
+
+	// lay out the utf-8 string `text' with `font' scaled to `size' pixels,
+	// the baseline starts at `pen' and new lines go down by the line height.
+	// the level of detail is the smallest one which is not magnified at
+	// `size'. characters missing from the atlas are skipped. returns the
+	// number of glyphs added, which is less than the number of glyphs of
+	// the run when the batch gets full
+	size_t add_run(const char * text, const sdf_atlas & font, float size, glm::vec2 pen);
+
+	inline const glyph_instance * data() const { return m_instances.data(); }
+	inline size_t size() const { return m_count; }
+	inline size_t capacity() const { return m_instances.size(); }
+private:
+	std::vector<glyph_instance> m_instances;
+	size_t m_count;
+};
+
+#endif //_TEXTBATCH_H_